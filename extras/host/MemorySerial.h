@@ -0,0 +1,31 @@
+/*
+ * MemorySerial.h - In-memory serial interface for host programs in extras/host.
+ *
+ * Bytes written are appended to tx, bytes placed in rx are returned by read().
+ */
+
+#ifndef MEMORY_SERIAL_H
+#define MEMORY_SERIAL_H
+
+#include <stdint.h>
+#include <deque>
+#include <vector>
+
+class MemorySerial {
+public:
+    std::deque<uint8_t> rx;
+    std::vector<uint8_t> tx;
+
+    uint8_t available() { return rx.size() > 255 ? 255 : (uint8_t) rx.size(); }
+    uint8_t read() {
+        uint8_t b = rx.front();
+        rx.pop_front();
+        return b;
+    }
+    uint8_t write(uint8_t b[], uint8_t len) {
+        tx.insert(tx.end(), b, b + len);
+        return len;
+    }
+};
+
+#endif
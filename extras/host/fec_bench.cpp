@@ -0,0 +1,71 @@
+/*
+ * Forward error correction benchmark. Sends frames with 16 byte payload over a channel
+ * that flips every bit with probability ber and reports delivered packets and goodput
+ * (payload bytes delivered per wire byte) for several parity lengths and bit error rates.
+ *
+ * Build and run from this directory:
+ *   make fec_bench
+ *   ./fec_bench [frames]
+ */
+
+#include "SimpleSerial.h"
+#include "MemorySerial.h"
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char **argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : 10000;
+    const uint8_t parity_lens[] = {0, 4, 8};
+    const double bers[] = {0, 1e-4, 1e-3, 3e-3, 1e-2};
+
+    printf("parity      ber  delivered  corrupted  goodput\n");
+    for (uint8_t parity_len : parity_lens) {
+        for (double ber : bers) {
+            MemorySerial serial_a, serial_b;
+            SimpleSerial a(&serial_a, 16, 8), b(&serial_b, 16, 8);
+            if (!a.set_fec(parity_len) || !b.set_fec(parity_len)) {
+                printf("set_fec(%u) failed\n", parity_len);
+                return 1;
+            }
+
+            std::mt19937 rng(42);
+            std::bernoulli_distribution flip(ber);
+            int delivered = 0, corrupted = 0;
+            size_t wire = 0;
+            for (int i = 0; i < frames; ++i) {
+                uint8_t id = i % 200 + 1;
+                uint8_t pld[16];
+                for (uint8_t k = 0; k < 16; ++k)
+                    pld[k] = i * 7 + k;
+                a.send(id, 16, pld);
+                a.loop(0);
+
+                for (uint8_t x : serial_a.tx) {
+                    for (uint8_t bit = 0; bit < 8; ++bit) {
+                        if (flip(rng))
+                            x ^= 1 << bit;
+                    }
+                    serial_b.rx.push_back(x);
+                }
+                wire += serial_a.tx.size();
+                serial_a.tx.clear();
+                b.loop(0);
+
+                while (b.available()) {
+                    SimpleSerial::Packet packet = b.read();
+                    bool ok = packet.id == id && packet.payload_len == 16;
+                    for (uint8_t k = 0; ok && k < 16; ++k)
+                        ok = packet.payload[k] == (uint8_t) (i * 7 + k);
+                    if (ok)
+                        delivered++;
+                    else
+                        corrupted++;
+                }
+            }
+            printf("%6u  %7.0e  %8.2f%%  %9d  %7.3f\n", parity_len, ber,
+                   100.0 * delivered / frames, corrupted, 16.0 * delivered / wire);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+/*
+ * Heap footprint benchmark. Replaces operator new / delete with versions that count live
+ * bytes, then runs N SimpleSerial instances that exchange 32 packets in flight in total
+ * (spread over all instances) per round, over serial interfaces with fixed buffers.
+ *
+ * Prints per instance count:
+ *   instances  heap after construction (before any traffic)
+ *   peak       largest heap while packets are in flight
+ *   idle       heap after all packets were read
+ *   empty      allocations made by default constructed (empty) Packet and LargePacket
+ * Bytes are counted as requested, without allocator overhead.
+ *
+ * Build and run from this directory:
+ *   make footprint_bench
+ *   ./footprint_bench [instances...]
+ */
+
+#include "SimpleSerial.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <cstddef>
+#include <new>
+
+static size_t live_bytes = 0;
+static size_t allocations = 0;
+
+// Size of each block is stored in front of it. Not inlined into operator new / delete,
+// so the compiler does not check the header offset against the allocated object.
+__attribute__((noinline)) static void *counted_alloc(size_t n) {
+    size_t *p = (size_t *) malloc(n + sizeof(std::max_align_t));
+    if (!p)
+        throw std::bad_alloc();
+    *p = n;
+    live_bytes += n;
+    allocations++;
+    return (char *) p + sizeof(std::max_align_t);
+}
+
+__attribute__((noinline)) static void counted_free(void *p) {
+    if (!p)
+        return;
+    size_t *block = (size_t *) ((char *) p - sizeof(std::max_align_t));
+    live_bytes -= *block;
+    free(block);
+}
+
+void *operator new(size_t n) { return counted_alloc(n); }
+void *operator new[](size_t n) { return counted_alloc(n); }
+void operator delete(void *p) noexcept { counted_free(p); }
+void operator delete[](void *p) noexcept { counted_free(p); }
+void operator delete(void *p, size_t) noexcept { counted_free(p); }
+void operator delete[](void *p, size_t) noexcept { counted_free(p); }
+
+// Serial interface with fixed buffers, so it does not allocate
+class BufferSerial {
+public:
+    uint8_t rx[1024], tx[1024];
+    uint16_t rx_head = 0, rx_tail = 0, tx_len = 0;
+
+    uint8_t available() { return rx_tail - rx_head > 255 ? 255 : rx_tail - rx_head; }
+    uint8_t read() { return rx[rx_head++]; }
+    uint8_t write(uint8_t b[], uint8_t len) {
+        memcpy(tx + tx_len, b, len);
+        tx_len += len;
+        return len;
+    }
+    // Loops written bytes back to receive buffer
+    void loop_back() {
+        memcpy(rx, tx, tx_len);
+        rx_head = 0;
+        rx_tail = tx_len;
+        tx_len = 0;
+    }
+};
+
+static void run(int n) {
+    BufferSerial *ports = new BufferSerial[n];
+    SimpleSerial **ss = new SimpleSerial *[n];
+    size_t base = live_bytes;
+
+    for (int i = 0; i < n; ++i)
+        ss[i] = new SimpleSerial(&ports[i], 64, 16);
+    size_t constructed = live_bytes - base;
+
+    size_t peak = 0;
+    for (int round = 0; round < 20; ++round) {
+        for (int m = 0; m < 32; ++m)
+            ss[m % n]->send_int(m, m);
+        for (int i = 0; i < n; ++i)
+            ss[i]->loop(0);
+        if (live_bytes - base > peak)
+            peak = live_bytes - base;
+        for (int i = 0; i < n; ++i)
+            ports[i].loop_back();
+        for (int i = 0; i < n; ++i) {
+            ss[i]->loop(0);
+            while (ss[i]->available())
+                ss[i]->read();
+        }
+        if (live_bytes - base > peak)
+            peak = live_bytes - base;
+    }
+    size_t idle = live_bytes - base;
+
+    printf("%9d %12zu %9zu %9zu %9zu\n", n, constructed, peak, idle, idle / n);
+
+    for (int i = 0; i < n; ++i)
+        delete ss[i];
+    delete [] ss;
+    delete [] ports;
+}
+
+int main(int argc, char **argv) {
+    size_t before = allocations;
+    {
+        SimpleSerial::Packet packet;
+        SimpleSerial::LargePacket large_packet;
+    }
+    printf("empty Packet + LargePacket: %zu allocations\n", allocations - before);
+
+    printf("instances constructed      peak      idle  idle per instance [bytes]\n");
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i)
+            run(atoi(argv[i]));
+    } else {
+        run(1);
+        run(16);
+        run(128);
+    }
+    return 0;
+}
@@ -0,0 +1,162 @@
+/*
+ * Pacing benchmark. Simulates an Arduino style control loop that calls loop() every 1 ms
+ * and sends telemetry, periodic bursts and priority frames over a UART with a small
+ * blocking TX buffer. Reports time blocked in loop() per call and latency from send()
+ * until the last byte of the frame leaves the wire, with and without set_baud_rate().
+ *
+ * Time is simulated, so results do not depend on the host.
+ *
+ * Build and run from this directory:
+ *   make pacing_bench
+ *   ./pacing_bench [baud] [tx_buffer_len] [seconds]
+ */
+
+#include "SimpleSerial.h"
+#include "MemorySerial.h"
+#include <algorithm>
+#include <deque>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static double now_us = 0;
+
+unsigned long sim_micros() { return (unsigned long) now_us; }
+unsigned long sim_millis() { return (unsigned long) (now_us / 1000); }
+
+/*
+ * UART with a TX buffer of capacity bytes, shifted out one byte every byte_us.
+ * write() blocks like Arduino HardwareSerial: it advances simulated time until
+ * every byte fits into the buffer. Wire bytes are decoded by receiver.
+ */
+class SimSerial {
+public:
+    SimSerial(double byte_us, uint16_t capacity) : byte_us(byte_us), capacity(capacity) {}
+
+    double byte_us;
+    uint16_t capacity;
+    double blocked_us = 0;
+    std::deque<double> start;   // times queued bytes start shifting out
+    double wire_free = 0;       // time last queued byte is shifted out
+    std::vector<std::pair<uint8_t, double>> wire; // bytes with time they are shifted out
+
+    void drain() {
+        while (!start.empty() && start.front() <= now_us)
+            start.pop_front();
+    }
+    uint8_t available() { return 0; }
+    uint8_t read() { return 0; }
+    int availableForWrite() {
+        drain();
+        return capacity - start.size();
+    }
+    uint8_t write(uint8_t b[], uint8_t len) {
+        for (uint8_t i = 0; i < len; ++i) {
+            drain();
+            if (start.size() >= capacity) {
+                blocked_us += start.front() - now_us;
+                now_us = start.front();
+                drain();
+            }
+            double s = std::max(now_us, wire_free);
+            wire_free = s + byte_us;
+            start.push_back(s);
+            wire.push_back(std::make_pair(b[i], wire_free));
+        }
+        return len;
+    }
+};
+
+struct Stats {
+    std::vector<double> v;
+    double at(double q) {
+        if (v.empty())
+            return 0;
+        std::sort(v.begin(), v.end());
+        return v[(size_t) (q * (v.size() - 1))];
+    }
+    void print(const char *name) {
+        printf("  %-18s n=%-6zu p50 %8.0f  p99 %8.0f  max %8.0f us\n",
+               name, v.size(), at(0.5), at(0.99), at(1.0));
+    }
+};
+
+static void run(uint32_t baud, uint16_t tx_buffer_len, uint32_t seconds, bool paced) {
+    now_us = 0;
+    SimSerial serial(1e6 * 10 / baud, tx_buffer_len);
+    SimpleSerial ss(&serial, 32, 32, sim_millis);
+    ss.set_micros_getter(sim_micros);
+    if (paced)
+        ss.set_baud_rate(baud);
+
+    Stats loop_blocked, telemetry_latency, priority_latency;
+    uint32_t dropped = 0;
+    double tick = 0;
+    for (uint32_t ms = 0; ms < seconds * 1000; ++ms) {
+        tick += 1000;
+        if (now_us < tick)
+            now_us = tick;
+
+        // Payload starts with send time, decoded again on the wire
+        uint8_t pld[32] = {0};
+        uint32_t stamp = (uint32_t) now_us;
+        memcpy(pld, &stamp, 4);
+
+        if (ms % 2 == 0) {
+            pld[4] = 1;
+            if (!ss.send(1, 8, pld))
+                dropped++;
+        }
+        if (ms % 100 == 0) {
+            pld[4] = 2;
+            for (uint8_t i = 0; i < 6; ++i) {
+                if (!ss.send(3, 32, pld))
+                    dropped++;
+            }
+        }
+        if (ms % 50 == 25) {
+            pld[4] = 3;
+            ss.send_priority(2, 8, pld);
+        }
+
+        double blocked = serial.blocked_us;
+        ss.loop();
+        loop_blocked.v.push_back(serial.blocked_us - blocked);
+    }
+
+    // Decode wire bytes and match frames to send times
+    MemorySerial wire_serial;
+    SimpleSerial receiver(&wire_serial, 32, 4);
+    for (size_t i = 0; i < serial.wire.size(); ++i) {
+        wire_serial.rx.push_back(serial.wire[i].first);
+        receiver.loop();
+        while (receiver.available()) {
+            SimpleSerial::Packet packet = receiver.read();
+            uint32_t stamp;
+            memcpy(&stamp, packet.payload, 4);
+            double latency = serial.wire[i].second - stamp;
+            if (packet.payload[4] == 1)
+                telemetry_latency.v.push_back(latency);
+            else if (packet.payload[4] == 3)
+                priority_latency.v.push_back(latency);
+        }
+    }
+
+    printf("%s (baud %u, TX buffer %u bytes, %u s)\n", paced ? "paced" : "unpaced",
+           baud, tx_buffer_len, seconds);
+    loop_blocked.print("loop() blocked");
+    telemetry_latency.print("telemetry latency");
+    priority_latency.print("priority latency");
+    printf("  send queue full:   %u\n\n", dropped);
+}
+
+int main(int argc, char **argv) {
+    uint32_t baud = argc > 1 ? atol(argv[1]) : 115200;
+    uint16_t tx_buffer_len = argc > 2 ? atoi(argv[2]) : 63;
+    uint32_t seconds = argc > 3 ? atol(argv[3]) : 10;
+
+    run(baud, tx_buffer_len, seconds, false);
+    run(baud, tx_buffer_len, seconds, true);
+    return 0;
+}
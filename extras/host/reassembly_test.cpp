@@ -0,0 +1,179 @@
+/*
+ * Large message reassembly test. Messages sent with send_large() are delivered frame by frame
+ * to a receiver with reassembly enabled, with simulated ms time.
+ *
+ * 1. Small frames interleaved with fragments: both arrive intact and in order.
+ * 2. New message while previous one is unread: previous one stays intact, new one is dropped.
+ * 3. Lost first fragment, lost middle fragment: message is dropped and counted once, next
+ *    message is received.
+ * 4. Lost last fragment: message is dropped and counted by loop() after receive_timeout
+ *    although nothing else is received.
+ *
+ * Build and run from this directory:
+ *   make reassembly_test
+ *   ./reassembly_test
+ * Exits with non-zero status if a check fails.
+ */
+
+#include "SimpleSerial.h"
+#include "MemorySerial.h"
+#include <stdio.h>
+
+static unsigned long now_ms = 0;
+unsigned long sim_millis() { return now_ms; }
+
+static bool ok = true;
+
+static void check(bool condition, const char *name) {
+    printf("%s: %s\n", condition ? "PASS" : "FAIL", name);
+    if (!condition)
+        ok = false;
+}
+
+typedef std::vector<std::vector<uint8_t>> Frames;
+
+// Encodes message of len bytes (fill, fill + 1, ...) into fragment frames. loop() sends one frame per call.
+static Frames fragments(SimpleSerial &sender, MemorySerial &serial, uint16_t len, uint8_t fill) {
+    std::vector<uint8_t> message(len);
+    for (uint16_t i = 0; i < len; ++i)
+        message[i] = fill + i;
+    sender.send_large(50, len, message.data());
+    Frames frames;
+    for (sender.loop(); !serial.tx.empty(); sender.loop()) {
+        frames.push_back(serial.tx);
+        serial.tx.clear();
+    }
+    return frames;
+}
+
+static bool intact(const SimpleSerial::LargePacket &packet, uint16_t len, uint8_t fill) {
+    if (packet.id != 50 || packet.payload_len != len)
+        return false;
+    for (uint16_t i = 0; i < len; ++i) {
+        if (packet.payload[i] != (uint8_t) (fill + i))
+            return false;
+    }
+    return true;
+}
+
+struct Receiver {
+    MemorySerial serial;
+    SimpleSerial ss;
+    Receiver() : ss(&serial, 16, 64, sim_millis) { ss.enable_reassembly(50, 1000); }
+
+    void deliver(const std::vector<uint8_t> &frame) {
+        serial.rx.insert(serial.rx.end(), frame.begin(), frame.end());
+        ss.loop(0);
+    }
+    void deliver(const Frames &frames, size_t skip = SIZE_MAX) {
+        for (size_t i = 0; i < frames.size(); ++i) {
+            if (i != skip)
+                deliver(frames[i]);
+        }
+    }
+};
+
+static void interleaved_small_frames() {
+    now_ms = 0;
+    MemorySerial sender_serial;
+    SimpleSerial sender(&sender_serial, 16, 8, sim_millis);
+    Receiver receiver;
+
+    std::vector<uint8_t> message(1000);
+    for (uint16_t i = 0; i < 1000; ++i)
+        message[i] = 7 + i;
+    sender.send_large(50, 1000, message.data());
+
+    // A small frame is queued every other loop(), next fragment is queued when send queue is
+    // empty, so they alternate on the line
+    int32_t sent = 0, received = 0;
+    bool in_order = true;
+    for (uint16_t step = 0; step < 200; ++step) {
+        if (step % 2 == 0)
+            sender.send_int(7, sent++);
+        sender.loop();
+        receiver.deliver(sender_serial.tx);
+        sender_serial.tx.clear();
+        while (receiver.ss.available()) {
+            if (byte_conversion::bytes_2_int(receiver.ss.read().payload) != received++)
+                in_order = false;
+        }
+        now_ms++;
+    }
+    check(received == sent && in_order, "small frames between fragments arrive in order");
+    check(receiver.ss.large_available() && intact(receiver.ss.read_large(), 1000, 7) &&
+          receiver.ss.large_dropped() == 0, "message with small frames between fragments is intact");
+}
+
+static void new_message_while_unread() {
+    now_ms = 0;
+    MemorySerial sender_serial;
+    SimpleSerial sender(&sender_serial, 16, 8, sim_millis);
+    Receiver receiver;
+
+    Frames first = fragments(sender, sender_serial, 100, 1);
+    Frames second = fragments(sender, sender_serial, 100, 2);
+    receiver.deliver(first);
+    receiver.deliver(second);
+    check(receiver.ss.large_dropped() == 1, "message arriving while previous one is unread is dropped once");
+    check(intact(receiver.ss.read_large(), 100, 1) && !receiver.ss.large_available(),
+          "unread message is not overwritten");
+}
+
+static void lost_fragment(size_t lost, const char *dropped_name, const char *next_name) {
+    now_ms = 0;
+    MemorySerial sender_serial;
+    SimpleSerial sender(&sender_serial, 16, 8, sim_millis);
+    Receiver receiver;
+
+    Frames broken = fragments(sender, sender_serial, 100, 3);
+    Frames next = fragments(sender, sender_serial, 100, 4);
+    receiver.deliver(broken, lost);
+    check(!receiver.ss.large_available() && receiver.ss.large_dropped() == 1, dropped_name);
+    receiver.deliver(next);
+    check(intact(receiver.ss.read_large(), 100, 4) && receiver.ss.large_dropped() == 1, next_name);
+}
+
+static void lost_last_fragment() {
+    now_ms = 0;
+    MemorySerial sender_serial;
+    SimpleSerial sender(&sender_serial, 16, 8, sim_millis);
+    Receiver receiver;
+
+    Frames broken = fragments(sender, sender_serial, 100, 5);
+    receiver.deliver(broken, broken.size() - 1);
+    now_ms = 500;
+    receiver.ss.loop(0);
+    bool kept = receiver.ss.large_dropped() == 0;
+    now_ms = 501;
+    receiver.ss.loop(0);
+    check(kept && receiver.ss.large_dropped() == 1 && !receiver.ss.large_available(),
+          "message without last fragment dropped after receive_timeout on silent line");
+
+    // Same with loop() instead of loop(budget_us)
+    Receiver plain;
+    now_ms = 0;
+    for (size_t i = 0; i + 1 < broken.size(); ++i) {
+        plain.serial.rx.insert(plain.serial.rx.end(), broken[i].begin(), broken[i].end());
+        for (uint8_t k = 0; k < 100; ++k)
+            plain.ss.loop();
+    }
+    now_ms = 501;
+    plain.ss.loop();
+    check(plain.ss.large_dropped() == 1, "loop() drops message without last fragment too");
+
+    Frames next = fragments(sender, sender_serial, 100, 6);
+    receiver.deliver(next);
+    check(intact(receiver.ss.read_large(), 100, 6) && receiver.ss.large_dropped() == 1,
+          "next message received after expired one");
+}
+
+int main() {
+    interleaved_small_frames();
+    new_message_while_unread();
+    lost_fragment(0, "message without first fragment is dropped once", "next message after lost first fragment");
+    lost_fragment(4, "message without middle fragment is dropped once", "next message after lost middle fragment");
+    lost_last_fragment();
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,221 @@
+/*
+ * Request / response test. A host SimpleRequester talks to a server SimpleSerial over
+ * in-memory serial interfaces with simulated ms time.
+ *
+ * 1. Pipelined requests: 200 requests are in flight at once, the server drops every
+ *    10th one. All replies must complete their own request, dropped ones time out.
+ *    One loop() call must dispatch all replies that arrived.
+ * 2. Late reply: a request times out, 255 more requests are sent, then the late reply
+ *    arrives. It must not complete any newer request.
+ * 3. request_async(): coroutines awaiting replies and timeouts (only if the compiler
+ *    supports C++20 coroutines, built with -std=c++20 by the Makefile).
+ *
+ * Build and run from this directory:
+ *   make requester_test
+ *   ./requester_test
+ * Exits with non-zero status if a check fails.
+ */
+
+#include "SimpleRequester.h"
+#include "MemorySerial.h"
+#include <stdio.h>
+
+static unsigned long now_ms = 0;
+unsigned long sim_millis() { return now_ms; }
+
+static bool ok = true;
+
+static void check(bool condition, const char *name) {
+    printf("%s: %s\n", condition ? "PASS" : "FAIL", name);
+    if (!condition)
+        ok = false;
+}
+
+// Host and server ends of a link
+struct Link {
+    MemorySerial host_serial, server_serial;
+    SimpleSerial host, server;
+    // Host queues are smaller than number of replies, so requester must drain receive queue
+    // while decoding
+    Link() : host(&host_serial, 16, 32, sim_millis), server(&server_serial, 16, 256, sim_millis) {}
+
+    // Moves bytes written by host to server
+    void to_server() {
+        host.loop(0);
+        server_serial.rx.insert(server_serial.rx.end(), host_serial.tx.begin(), host_serial.tx.end());
+        host_serial.tx.clear();
+        server.loop(0);
+    }
+
+    // Moves bytes written by server to host
+    void to_host() {
+        server.loop(0);
+        host_serial.rx.insert(host_serial.rx.end(), server_serial.tx.begin(), server_serial.tx.end());
+        server_serial.tx.clear();
+    }
+
+    // Server replies with value * 2, skips values divisible by drop_every
+    void serve(int32_t drop_every) {
+        while (server.available()) {
+            SimpleSerial::Packet request = server.read();
+            int32_t value = byte_conversion::bytes_2_int(request.payload + 1);
+            if (drop_every && value % drop_every == 0)
+                continue;
+            uint8_t result[4];
+            byte_conversion::int_2_bytes(value * 2, result);
+            SimpleRequester::reply(server, request, 4, result);
+        }
+    }
+};
+
+struct Expected {
+    int32_t value;
+    uint8_t status = 0xFF;
+    bool correct = false;
+};
+
+static void on_reply(void *context, uint8_t status, const SimpleSerial::Packet &reply) {
+    Expected *e = static_cast<Expected *>(context);
+    e->status = status;
+    e->correct = status == SimpleRequester::REPLY_TIMEOUT ||
+                 (reply.payload_len == 4 && byte_conversion::bytes_2_int(reply.payload) == e->value * 2);
+}
+
+static void pipelined_requests() {
+    now_ms = 0;
+    Link link;
+    SimpleRequester requester(link.host, sim_millis, 100);
+
+    static Expected expected[200];
+    for (int32_t i = 0; i < 200; ++i) {
+        expected[i] = Expected();
+        expected[i].value = i;
+        uint8_t payload[4];
+        byte_conversion::int_2_bytes(i, payload);
+        requester.request(19, 4, payload, on_reply, &expected[i]);
+        if (i % 20 == 19)
+            link.to_server();
+    }
+    check(requester.in_flight() == 200, "200 requests in flight");
+
+    link.serve(10);
+    link.to_host();
+    requester.loop();
+    int replied = 0, correct = 0;
+    for (int32_t i = 0; i < 200; ++i) {
+        replied += expected[i].status == SimpleRequester::REPLY_OK;
+        correct += expected[i].correct;
+    }
+    check(replied == 180 && correct == 180 && requester.in_flight() == 20,
+          "one loop() dispatches 180 replies to their own requests");
+
+    now_ms = 100;
+    requester.loop();
+    int timeouts = 0;
+    for (int32_t i = 0; i < 200; ++i)
+        timeouts += expected[i].status == SimpleRequester::REPLY_TIMEOUT && i % 10 == 0;
+    check(timeouts == 20 && requester.in_flight() == 0 && !requester.available(),
+          "dropped requests time out");
+}
+
+static void late_reply() {
+    now_ms = 0;
+    Link link;
+    SimpleRequester requester(link.host, sim_millis, 100);
+
+    static Expected first;
+    first = Expected();
+    first.value = 1000;
+    uint8_t payload[4];
+    byte_conversion::int_2_bytes(first.value, payload);
+    requester.request(19, 4, payload, on_reply, &first);
+    link.to_server();
+
+    now_ms = 100;
+    requester.loop();
+    check(first.status == SimpleRequester::REPLY_TIMEOUT, "request times out");
+
+    // Cycle through all other correlation bytes while late reply is outstanding
+    static Expected newer[256];
+    int sent = 0;
+    for (int32_t i = 0; i < 256; ++i) {
+        newer[i] = Expected();
+        newer[i].value = i;
+        byte_conversion::int_2_bytes(i, payload);
+        sent += requester.request(19, 4, payload, on_reply, &newer[i]);
+        link.host.loop(0);
+        link.host_serial.tx.clear();
+    }
+    check(sent == 255, "timed out correlation byte is not reused");
+
+    // Late reply arrives
+    link.serve(0);
+    link.to_host();
+    requester.loop();
+    int completed = 0;
+    for (int32_t i = 0; i < 256; ++i)
+        completed += newer[i].status != 0xFF;
+    check(completed == 0 && !requester.available(), "late reply does not complete a newer request");
+
+    byte_conversion::int_2_bytes(0, payload);
+    check(requester.request(19, 4, payload, on_reply, &newer[255]), "late reply frees correlation byte");
+}
+
+#ifdef SIMPLE_REQUESTER_COROUTINES
+struct Task {
+    struct promise_type {
+        Task get_return_object() { return {}; }
+        std::suspend_never initial_suspend() { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() {}
+    };
+};
+
+static int async_ok = 0, async_timeouts = 0, async_wrong = 0;
+
+static Task async_request(SimpleRequester &requester, int32_t value) {
+    uint8_t payload[4];
+    byte_conversion::int_2_bytes(value, payload);
+    SimpleRequester::Reply reply = co_await requester.request_async(19, 4, payload);
+    if (reply.status == SimpleRequester::REPLY_OK && byte_conversion::bytes_2_int(reply.packet.payload) == value * 2)
+        async_ok++;
+    else if (reply.status == SimpleRequester::REPLY_TIMEOUT && value % 10 == 0)
+        async_timeouts++;
+    else
+        async_wrong++;
+}
+
+static void awaited_requests() {
+    now_ms = 0;
+    Link link;
+    SimpleRequester requester(link.host, sim_millis, 100);
+    for (int32_t i = 0; i < 50; ++i) {
+        async_request(requester, i);
+        if (i % 10 == 9)
+            link.to_server();
+    }
+
+    link.serve(10);
+    link.to_host();
+    requester.loop();
+    check(async_ok == 45 && async_wrong == 0, "request_async() resumes with replies");
+
+    now_ms = 100;
+    requester.loop();
+    check(async_timeouts == 5 && async_wrong == 0 && requester.in_flight() == 0,
+          "request_async() resumes with timeouts");
+}
+#endif
+
+int main() {
+    pipelined_requests();
+    late_reply();
+#ifdef SIMPLE_REQUESTER_COROUTINES
+    awaited_requests();
+#else
+    printf("SKIP: request_async() (compiler without C++20 coroutines)\n");
+#endif
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
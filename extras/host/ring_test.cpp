@@ -0,0 +1,148 @@
+/*
+ * Receive ring test. A producer thread pushes frames byte by byte with on_rx_byte().
+ *
+ * 1. Stalled consumer: producer pushes at line rate while the consumer (main loop) is
+ *    stalled, then the consumer drains the ring. All frames that fit into the ring must
+ *    be received, bytes beyond ring capacity are dropped.
+ * 2. Concurrent consumer: producer pushes at line rate while the consumer drains the ring
+ *    with loop(0). The ring must not overflow and all frames must arrive in order.
+ * 3. Concurrent consumer, producer at full speed: producer retries bytes while the ring is
+ *    full. All frames must arrive in order.
+ *
+ * Build and run from this directory:
+ *   make ring_test
+ *   ./ring_test [baud] [ring_len]
+ * Exits with non-zero status if a frame was lost or arrived out of order.
+ */
+
+#include "SimpleSerial.h"
+#include "MemorySerial.h"
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+struct Stream {
+    std::vector<uint8_t> bytes;
+    std::vector<size_t> frame_end; // stream length after each frame
+};
+
+// Encode frames with sequence numbers as payload
+static Stream encode(size_t min_len) {
+    MemorySerial encoder_serial;
+    SimpleSerial encoder(&encoder_serial, 16, 1);
+    Stream stream;
+    for (int32_t i = 0; stream.bytes.size() < min_len; ++i) {
+        encoder.send_int(1, i);
+        encoder.loop();
+        stream.bytes.insert(stream.bytes.end(), encoder_serial.tx.begin(), encoder_serial.tx.end());
+        encoder_serial.tx.clear();
+        stream.frame_end.push_back(stream.bytes.size());
+    }
+    return stream;
+}
+
+// Reads received packets, returns false if a packet is out of order
+static bool read_in_order(SimpleSerial &ss, int32_t &received) {
+    bool in_order = true;
+    while (ss.available()) {
+        SimpleSerial::Packet packet = ss.read();
+        if (byte_conversion::bytes_2_int(packet.payload) != received)
+            in_order = false;
+        received++;
+    }
+    return in_order;
+}
+
+static bool stalled_consumer(const Stream &stream, double byte_ns, uint16_t ring_len) {
+    MemorySerial serial;
+    SimpleSerial ss(&serial, 16, 1024);
+    ss.enable_rx_ring(ring_len);
+
+    // Producer pushes at line rate, consumer is stalled until producer is done
+    size_t accepted = 0;
+    std::thread producer([&] {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < stream.bytes.size(); ++i) {
+            auto due = start + std::chrono::nanoseconds((long long) (i * byte_ns));
+            while (std::chrono::steady_clock::now() < due) {}
+            if (ss.on_rx_byte(stream.bytes[i]))
+                accepted++;
+        }
+    });
+    producer.join();
+
+    ss.loop(0);
+    int32_t received = 0;
+    bool in_order = read_in_order(ss, received);
+
+    // Frames completely inside the ring capacity
+    int32_t expected = 0;
+    while (expected < (int32_t) stream.frame_end.size() && stream.frame_end[expected] <= ring_len)
+        expected++;
+
+    bool ok = accepted == ring_len && received == expected && in_order;
+    printf("%s: stalled consumer, pushed %zu bytes, accepted %zu, frames expected %d, received %d\n",
+           ok ? "PASS" : "FAIL", stream.bytes.size(), accepted, expected, received);
+    return ok;
+}
+
+static bool concurrent_consumer(const Stream &stream, double byte_ns, uint16_t ring_len, bool retry) {
+    MemorySerial serial;
+    SimpleSerial ss(&serial, 16, 1024);
+    ss.enable_rx_ring(ring_len);
+
+    // Producer pushes at line rate, or as fast as possible retrying while ring is full
+    std::atomic<size_t> dropped(0);
+    std::atomic<bool> done(false);
+    std::thread producer([&] {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < stream.bytes.size(); ++i) {
+            if (retry) {
+                while (!ss.on_rx_byte(stream.bytes[i]))
+                    std::this_thread::yield();
+                continue;
+            }
+            auto due = start + std::chrono::nanoseconds((long long) (i * byte_ns));
+            while (std::chrono::steady_clock::now() < due)
+                std::this_thread::yield();
+            if (!ss.on_rx_byte(stream.bytes[i]))
+                dropped++;
+        }
+        done = true;
+    });
+
+    // Consumer drains ring while producer is running
+    int32_t expected = stream.frame_end.size();
+    int32_t received = 0;
+    bool in_order = true;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (received < expected && std::chrono::steady_clock::now() < deadline) {
+        bool producer_done = done;
+        ss.loop(0);
+        in_order &= read_in_order(ss, received);
+        if (producer_done && ss.loop(0) == 0 && !ss.available())
+            break;
+    }
+    producer.join();
+
+    bool ok = dropped == 0 && received == expected && in_order;
+    printf("%s: concurrent consumer, %s, pushed %zu bytes, dropped %zu, frames expected %d, received %d%s\n",
+           ok ? "PASS" : "FAIL", retry ? "producer at full speed" : "producer at line rate",
+           stream.bytes.size(), (size_t) dropped, expected, received, in_order ? "" : ", out of order");
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    uint32_t baud = argc > 1 ? atol(argv[1]) : 115200;
+    uint16_t ring_len = argc > 2 ? atoi(argv[2]) : 1024;
+    double byte_ns = 1e9 * 10 / baud;
+    printf("baud %u, ring %u bytes\n", baud, ring_len);
+
+    bool ok = stalled_consumer(encode(2u * ring_len), byte_ns, ring_len);
+    ok &= concurrent_consumer(encode(4u * ring_len), byte_ns, ring_len, false);
+    ok &= concurrent_consumer(encode(200000), byte_ns, ring_len, true);
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
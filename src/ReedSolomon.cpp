@@ -0,0 +1,162 @@
+#include "ReedSolomon.h"
+#include <string.h>
+
+namespace {
+    // Multiplication in GF(256) with primitive polynomial 0x11d
+    uint8_t gf_mul(uint8_t a, uint8_t b) {
+        uint8_t result = 0;
+        while (b) {
+            if (b & 1)
+                result ^= a;
+            a = (a & 0x80) ? (uint8_t)((a << 1) ^ 0x1d) : (uint8_t)(a << 1);
+            b >>= 1;
+        }
+        return result;
+    }
+
+    uint8_t gf_pow(uint8_t a, uint8_t n) {
+        uint8_t result = 1;
+        while (n) {
+            if (n & 1)
+                result = gf_mul(result, a);
+            a = gf_mul(a, a);
+            n >>= 1;
+        }
+        return result;
+    }
+
+    uint8_t gf_inv(uint8_t a) {
+        return gf_pow(a, 254);
+    }
+
+    // Evaluates polynomial with coefficients p[0] (lowest degree) ... p[len - 1] at x
+    uint8_t poly_eval(uint8_t const *p, uint8_t len, uint8_t x) {
+        uint8_t y = 0;
+        for (int16_t i = len - 1; i >= 0; --i)
+            y = gf_mul(y, x) ^ p[i];
+        return y;
+    }
+
+    // Calculates syndromes of block. Returns true if all are zero (no errors).
+    bool calc_syndromes(uint8_t const *block, uint8_t len, uint8_t nsym, uint8_t *synd) {
+        bool clean = true;
+        for (uint8_t j = 0; j < nsym; ++j) {
+            // Block byte 0 is the highest degree coefficient
+            uint8_t x = gf_pow(2, j);
+            uint8_t y = 0;
+            for (uint8_t k = 0; k < len; ++k)
+                y = gf_mul(y, x) ^ block[k];
+            synd[j] = y;
+            if (y)
+                clean = false;
+        }
+        return clean;
+    }
+}
+
+void reed_solomon::encode(uint8_t const *msg, uint8_t len, uint8_t *parity, uint8_t nsym) {
+    // Generator polynomial, highest degree first: gen = (x - a^0)(x - a^1)...(x - a^(nsym-1))
+    uint8_t gen[max_parity_len + 1];
+    memset(gen, 0, sizeof(gen));
+    gen[0] = 1;
+    for (uint8_t i = 0; i < nsym; ++i) {
+        uint8_t root = gf_pow(2, i);
+        for (uint8_t j = i + 1; j > 0; --j)
+            gen[j] ^= gf_mul(gen[j - 1], root);
+    }
+
+    // Remainder of msg * x^nsym divided by generator
+    memset(parity, 0, nsym);
+    for (uint8_t i = 0; i < len; ++i) {
+        uint8_t coef = msg[i] ^ parity[0];
+        memmove(parity, parity + 1, nsym - 1);
+        parity[nsym - 1] = 0;
+        if (coef) {
+            for (uint8_t j = 0; j < nsym; ++j)
+                parity[j] ^= gf_mul(gen[j + 1], coef);
+        }
+    }
+}
+
+bool reed_solomon::decode(uint8_t *block, uint8_t len, uint8_t nsym) {
+    if (nsym == 0 || nsym > max_parity_len || len <= nsym)
+        return false;
+
+    uint8_t synd[max_parity_len];
+    if (calc_syndromes(block, len, nsym, synd))
+        return true;
+
+    // Berlekamp-Massey. Error locator polynomial, lowest degree first.
+    uint8_t loc[max_parity_len + 1];
+    uint8_t prev[max_parity_len + 1];
+    uint8_t tmp[max_parity_len + 1];
+    memset(loc, 0, sizeof(loc));
+    memset(prev, 0, sizeof(prev));
+    loc[0] = 1;
+    prev[0] = 1;
+    uint8_t loc_len = 0; // number of errors
+    uint8_t shift = 1;
+    uint8_t prev_d = 1;
+    for (uint8_t r = 0; r < nsym; ++r) {
+        uint8_t d = synd[r];
+        for (uint8_t i = 1; i <= loc_len; ++i)
+            d ^= gf_mul(loc[i], synd[r - i]);
+        if (d == 0) {
+            shift++;
+            continue;
+        }
+        uint8_t coef = gf_mul(d, gf_inv(prev_d));
+        if (2 * loc_len <= r) {
+            memcpy(tmp, loc, sizeof(loc));
+            for (uint8_t i = 0; i + shift <= nsym; ++i)
+                loc[i + shift] ^= gf_mul(coef, prev[i]);
+            loc_len = r + 1 - loc_len;
+            memcpy(prev, tmp, sizeof(prev));
+            prev_d = d;
+            shift = 1;
+        } else {
+            for (uint8_t i = 0; i + shift <= nsym; ++i)
+                loc[i + shift] ^= gf_mul(coef, prev[i]);
+            shift++;
+        }
+    }
+    if (2 * loc_len > nsym)
+        return false;
+
+    // Error evaluator: omega = synd * loc mod x^nsym
+    uint8_t omega[max_parity_len];
+    for (uint8_t i = 0; i < nsym; ++i) {
+        omega[i] = 0;
+        for (uint8_t j = 0; j <= i && j <= loc_len; ++j)
+            omega[i] ^= gf_mul(loc[j], synd[i - j]);
+    }
+
+    // Chien search and Forney algorithm
+    uint8_t found = 0;
+    for (uint8_t k = 0; k < len; ++k) {
+        uint8_t x = gf_pow(2, len - 1 - k); // error location value of block byte k
+        uint8_t x_inv = gf_inv(x);
+        if (poly_eval(loc, loc_len + 1, x_inv) != 0)
+            continue;
+
+        // Formal derivative of locator at x_inv: odd terms only
+        uint8_t x_inv2 = gf_mul(x_inv, x_inv);
+        uint8_t deriv = 0;
+        uint8_t x_pow = 1;
+        for (uint8_t i = 1; i <= loc_len; i += 2) {
+            deriv ^= gf_mul(loc[i], x_pow);
+            x_pow = gf_mul(x_pow, x_inv2);
+        }
+        if (deriv == 0)
+            return false;
+
+        uint8_t e = gf_mul(x, gf_mul(poly_eval(omega, nsym, x_inv), gf_inv(deriv)));
+        block[k] ^= e;
+        found++;
+    }
+    if (found != loc_len)
+        return false;
+
+    // Verify correction
+    return calc_syndromes(block, len, nsym, synd);
+}
@@ -0,0 +1,26 @@
+/*
+ * ReedSolomon.h - Reed-Solomon forward error correction over GF(256).
+ *
+ * Systematic code with primitive polynomial 0x11d and generator roots a^0 ... a^(nsym-1).
+ * With nsym parity bytes, up to nsym / 2 corrupted bytes in a block can be corrected.
+ * Galois field arithmetic is computed without lookup tables to keep RAM use low.
+ */
+
+#ifndef REED_SOLOMON_H
+#define REED_SOLOMON_H
+
+#include <stdint.h>
+
+namespace reed_solomon {
+    // Max number of parity bytes
+    const uint8_t max_parity_len = 32;
+
+    // Calculates nsym parity bytes of len message bytes. Block length (len + nsym) must be <= 255.
+    void encode(uint8_t const *msg, uint8_t len, uint8_t *parity, uint8_t nsym);
+
+    // Corrects block of len bytes (message followed by nsym parity bytes) in place.
+    // Returns false if block has too many errors to be corrected.
+    bool decode(uint8_t *block, uint8_t len, uint8_t nsym);
+}
+
+#endif
@@ -54,9 +54,12 @@ public:
         delete [] data_;
     }
     uint16_t count();
+    uint16_t max_count();
     uint16_t front();
     uint16_t back();
-    void push(const T &item);
+    T &at(uint16_t slot);
+    bool push(const T &item);
+    bool push_front(const T &item);
     T peek();
     T pop();
     void clear();
@@ -68,6 +71,12 @@ inline uint16_t SimpleQueue<T>::count()
     return count_;
 }
 
+template<class T>
+inline uint16_t SimpleQueue<T>::max_count()
+{
+    return maxitems_;
+}
+
 template<class T>
 inline uint16_t SimpleQueue<T>::front()
 {
@@ -80,8 +89,16 @@ inline uint16_t SimpleQueue<T>::back()
     return back_;
 }
 
+// Returns item stored in slot. Slot of the oldest item is front().
+template<class T>
+inline T &SimpleQueue<T>::at(uint16_t slot)
+{
+    return data_[slot];
+}
+
+// Returns false if queue is full and item was dropped.
 template<class T>
-void SimpleQueue<T>::push(const T &item)
+bool SimpleQueue<T>::push(const T &item)
 {
     if(count_ < maxitems_) { // Drops out when full
         data_[back_++]=item;
@@ -89,14 +106,35 @@ void SimpleQueue<T>::push(const T &item)
         // Check wrap around
         if (back_ > maxitems_)
             back_ -= (maxitems_ + 1);
+        return true;
+    }
+    return false;
+}
+
+// Places item in front of all other items, so it is popped first.
+// Returns false if queue is full and item was dropped.
+template<class T>
+bool SimpleQueue<T>::push_front(const T &item)
+{
+    if(count_ < maxitems_) { // Drops out when full
+        // Check wrap around
+        if (front_ == 0)
+            front_ = maxitems_;
+        else
+            --front_;
+        data_[front_]=item;
+        ++count_;
+        return true;
     }
+    return false;
 }
 
 template<class T>
 T SimpleQueue<T>::pop() {
     if(count_ <= 0) return T(); // Returns empty
     else {
-        T result = data_[front_];
+        // Move item out, so slot does not keep its buffers
+        T result(static_cast<T&&>(data_[front_]));
         front_++;
         --count_;
         // Check wrap around
@@ -0,0 +1,151 @@
+#include "SimpleRequester.h"
+#include <string.h>
+
+/*
+ * Prepends a free correlation byte to payload and sends it. The request is
+ * tracked until reply with the same id and correlation byte arrives or timeout expires.
+ */
+bool SimpleRequester::request(uint8_t id, uint8_t len, uint8_t const *payload,
+                              Callback callback, void *context, uint16_t timeout) {
+    if (!callback || len == 0xFF || pending_count + quarantined_count >= 256)
+        return false;
+
+    // Find free correlation byte
+    uint8_t correlation = next_correlation;
+    while (pending[correlation].callback || pending[correlation].quarantined)
+        correlation++;
+
+    uint8_t pld[len + 1];
+    pld[0] = correlation;
+    memcpy(pld + 1, payload, len);
+    if (!ss_.send(id, len + 1, pld))
+        return false;
+
+    Pending &p = pending[correlation];
+    p.callback = callback;
+    p.context = context;
+    p.timeout = timeout ? timeout : this->timeout;
+    p.deadline = sys_time() + p.timeout;
+    p.id = id;
+    pending_count++;
+    next_correlation = correlation + 1;
+    return true;
+}
+
+/*
+ * Sends payload with id of request, prepended with correlation byte of request.
+ */
+bool SimpleRequester::reply(SimpleSerial &ss, const SimpleSerial::Packet &request,
+                            uint8_t len, uint8_t const *payload) {
+    if (request.payload_len == 0 || len == 0xFF)
+        return false;
+
+    uint8_t pld[len + 1];
+    pld[0] = request.payload[0];
+    memcpy(pld + 1, payload, len);
+    return ss.send(request.id, len + 1, pld);
+}
+
+/*
+ * Continuously running loop. Matches received packets to pending requests by
+ * id and correlation byte and calls their callbacks. Other packets are placed
+ * in queue of unsolicited packets. Budgeted SimpleSerial::loop() stops decoding
+ * when receive queue is full, so it runs again as long as packets are dispatched.
+ */
+void SimpleRequester::loop(uint32_t budget_us) {
+    uint16_t waiting;
+    bool dispatched;
+    do {
+        waiting = ss_.loop(budget_us);
+        dispatched = false;
+        while (ss_.available()) {
+            dispatch(ss_.read());
+            dispatched = true;
+        }
+    } while (waiting > 0 && dispatched);
+
+    if (pending_count == 0 && quarantined_count == 0)
+        return;
+
+    // Expire timed out requests and quarantined correlation bytes
+    uint32_t time = sys_time();
+    for (uint16_t i = 0; i < 256; ++i) {
+        Pending &p = pending[i];
+        if ((int32_t)(time - p.deadline) < 0)
+            continue;
+        if (p.callback)
+            complete(i, REPLY_TIMEOUT, SimpleSerial::Packet());
+        else if (p.quarantined)
+            release(i);
+    }
+}
+
+/*
+ * Completes pending request the packet replies to, otherwise places it in
+ * queue of unsolicited packets.
+ */
+void SimpleRequester::dispatch(const SimpleSerial::Packet &packet) {
+    if (packet.payload_len > 0) {
+        uint8_t correlation = packet.payload[0];
+        Pending &p = pending[correlation];
+        if (p.callback && p.id == packet.id) {
+            SimpleSerial::Packet reply(packet.id, packet.payload_len - 1, packet.payload + 1);
+            complete(correlation, REPLY_OK, reply);
+            return;
+        }
+        if (p.quarantined && p.id == packet.id) {
+            // Late reply to timed out request
+            release(correlation);
+            return;
+        }
+    }
+    unsolicited_queue.push(packet);
+}
+
+/*
+ * Frees request slot and calls callback. Slot is freed first, so callback
+ * may send new requests. On timeout correlation byte is quarantined for one
+ * more timeout, so that a late reply can not complete a newer request.
+ */
+void SimpleRequester::complete(uint8_t correlation, uint8_t status, const SimpleSerial::Packet &reply) {
+    Pending &p = pending[correlation];
+    Callback callback = p.callback;
+    void *context = p.context;
+    p.callback = nullptr;
+    pending_count--;
+    if (status == REPLY_TIMEOUT) {
+        p.quarantined = true;
+        p.deadline = sys_time() + p.timeout;
+        quarantined_count++;
+    }
+    callback(context, status, reply);
+}
+
+/*
+ * Makes quarantined correlation byte available again.
+ */
+void SimpleRequester::release(uint8_t correlation) {
+    pending[correlation].quarantined = false;
+    quarantined_count--;
+}
+
+bool SimpleRequester::available() {
+    return unsolicited_queue.count();
+}
+
+SimpleSerial::Packet SimpleRequester::read() {
+    return unsolicited_queue.pop();
+}
+
+uint16_t SimpleRequester::in_flight() {
+    return pending_count;
+}
+
+/*
+ * Return system time if time_getter function is set, otherwise return 0.
+ */
+uint32_t SimpleRequester::sys_time() {
+    if (time_getter)
+        return (uint32_t) time_getter();
+    return 0;
+}
@@ -0,0 +1,152 @@
+/*
+ * SimpleRequester.h - Asynchronous request / response on top of SimpleSerial.
+ *
+ * Intended for the host side of a link where the other side acts as a server.
+ * Every request carries a correlation byte as the first payload byte. The server
+ * replies with the same id and echoes the correlation byte (see reply()), so many
+ * requests, also with the same id, can be in flight over one link at the same time.
+ *
+ * Example:
+ *
+ * void on_reply(void *context, uint8_t status, const SimpleSerial::Packet &reply) { ... }
+ *
+ * SimpleRequester requester(ss, millis);
+ * requester.request(19, 4, payload, on_reply, nullptr);
+ * while (true)
+ *     requester.loop();
+ *
+ * With C++20 coroutines a request can be awaited instead:
+ *
+ * SimpleRequester::Reply reply = co_await requester.request_async(19, 4, payload);
+ */
+
+#ifndef SimpleRequester_h
+#define SimpleRequester_h
+
+#include <stdint.h>
+#include "SimpleSerial.h"
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define SIMPLE_REQUESTER_COROUTINES
+#endif
+#endif
+
+
+class SimpleRequester {
+public:
+    // Request status passed to callback
+    static const uint8_t REPLY_OK = 0;
+    static const uint8_t REPLY_TIMEOUT = 1;
+    static const uint8_t REQUEST_FAILED = 2; // only returned by request_async()
+
+    // Called from loop() with reply (correlation byte removed) or empty packet on timeout
+    typedef void (*Callback)(void *context, uint8_t status, const SimpleSerial::Packet &reply);
+
+    explicit SimpleRequester(SimpleSerial &ss, // link to send requests over
+            unsigned long (*time_getter)(), // function that returns system time in ms. like millis().
+            uint16_t timeout = 500, // [ms] default time after which request without reply fails
+            uint16_t max_queue_len = 8) // max len of queue of received packets that are not replies
+                : ss_(ss)
+                , time_getter(time_getter)
+                , timeout(timeout)
+                , unsolicited_queue(max_queue_len)
+            {}
+    SimpleRequester(const SimpleRequester&) = delete;
+
+    // Send request. Callback is called from loop() once reply arrives or timeout [ms] expires
+    // (0 uses default timeout). Payload can be at most max_payload_len - 1 bytes long.
+    // Returns false if request could not be sent (payload too long, send queue full or
+    // all 256 correlation ids in flight or reserved after timeout). Callback is not called in that case.
+    bool request(uint8_t id, uint8_t len, uint8_t const payload[],
+                 Callback callback, void *context, uint16_t timeout = 0);
+
+    // Server side. Send reply to request packet, echoing its correlation byte.
+    static bool reply(SimpleSerial &ss, const SimpleSerial::Packet &request,
+                      uint8_t len, uint8_t const payload[]);
+
+    // Handler loop. Runs budgeted SimpleSerial::loop(budget_us) (0 means no time limit), so all
+    // received replies are decoded in one call, dispatches replies and expires timed out requests.
+    // SimpleSerial::loop() runs again while it filled up receive queue, budget_us applies to each run.
+    void loop(uint32_t budget_us = 0);
+
+    // Received packets that are not replies to pending requests
+    bool available();
+    SimpleSerial::Packet read();
+
+    // Number of requests waiting for reply. After timeout a correlation byte stays reserved for
+    // one more timeout, so a late reply is discarded instead of completing a newer request.
+    uint16_t in_flight();
+
+#ifdef SIMPLE_REQUESTER_COROUTINES
+    struct Reply {
+        uint8_t status;
+        SimpleSerial::Packet packet;
+    };
+
+    class RequestAwaitable {
+    public:
+        RequestAwaitable(SimpleRequester &requester, uint8_t id, uint8_t len,
+                         uint8_t const payload[], uint16_t timeout)
+            : requester_(requester), id_(id), len_(len), payload_(payload), timeout_(timeout) {}
+        bool await_ready() { return false; }
+        bool await_suspend(std::coroutine_handle<> handle) {
+            handle_ = handle;
+            if (requester_.request(id_, len_, payload_, &on_reply, this, timeout_))
+                return true;
+            result_.status = REQUEST_FAILED;
+            return false;
+        }
+        Reply await_resume() { return result_; }
+    private:
+        static void on_reply(void *context, uint8_t status, const SimpleSerial::Packet &reply) {
+            RequestAwaitable *self = static_cast<RequestAwaitable *>(context);
+            self->result_.status = status;
+            self->result_.packet = reply;
+            self->handle_.resume();
+        }
+        SimpleRequester &requester_;
+        uint8_t id_;
+        uint8_t len_;
+        uint8_t const *payload_;
+        uint16_t timeout_;
+        std::coroutine_handle<> handle_;
+        Reply result_ {};
+    };
+
+    // Awaitable request. Coroutine is resumed from loop() with reply or timeout status.
+    RequestAwaitable request_async(uint8_t id, uint8_t len, uint8_t const payload[], uint16_t timeout = 0) {
+        return RequestAwaitable(*this, id, len, payload, timeout);
+    }
+#endif
+
+private:
+    struct Pending {
+        Callback callback = nullptr; // nullptr if no request is waiting for reply
+        void *context = nullptr;
+        uint32_t deadline = 0;
+        uint16_t timeout = 0;
+        uint8_t id = 0;
+        bool quarantined = false; // timed out, slot is not reused until late reply or deadline
+    };
+
+    SimpleSerial &ss_;
+    unsigned long (*time_getter)();
+    const uint16_t timeout;
+
+    // Pending requests indexed by correlation byte
+    Pending pending[256];
+    uint16_t pending_count = 0;
+    uint16_t quarantined_count = 0;
+    uint8_t next_correlation = 0;
+
+    SimpleQueue<SimpleSerial::Packet> unsolicited_queue;
+
+    uint32_t sys_time();
+    void dispatch(const SimpleSerial::Packet &packet);
+    void complete(uint8_t correlation, uint8_t status, const SimpleSerial::Packet &reply);
+    void release(uint8_t correlation);
+};
+
+#endif
@@ -0,0 +1,145 @@
+/*
+ * SimpleRing.h
+ *
+ * Wait-free single producer / single consumer ring buffer. One side (for example
+ * an interrupt handler or DMA complete callback) only pushes and the other side
+ * (main loop) only pops. Neither side ever blocks or disables interrupts.
+ *
+ * On AVR indices are single bytes (which are read and written atomically), so
+ * max size is 254 items. On other platforms std::atomic is used.
+ *
+ * Examples:
+ *
+ * SimpleRing<uint8_t> ring(64);
+ * ring.push(b);                 // in ISR
+ * while (ring.count())          // in main loop
+ *     process(ring.pop());
+ *
+ */
+
+#ifndef SIMPLE_RING_H
+#define SIMPLE_RING_H
+
+#include <stdint.h>
+#if !defined(__AVR__)
+#include <atomic>
+#endif
+
+template<class T>
+class SimpleRing {
+private:
+#if defined(__AVR__)
+    typedef volatile uint8_t index_t;
+#else
+    typedef std::atomic<uint16_t> index_t;
+#endif
+    index_t head_; // next slot to write. Written by producer only.
+    index_t tail_; // next slot to read. Written by consumer only.
+    uint16_t len_; // number of slots, one slot is always left empty
+    T *data_;
+
+    static uint16_t load(index_t &i);
+    static void store(index_t &i, uint16_t value);
+    uint16_t next(uint16_t i) { return (i + 1 == len_) ? 0 : i + 1; }
+public:
+    explicit SimpleRing(uint16_t maxitems)
+        : head_(0)
+        , tail_(0)
+        , len_(maxitems + 1)
+        , data_(new T[len_])
+        {}
+    ~SimpleRing() {
+        delete [] data_;
+    }
+    SimpleRing(const SimpleRing&) = delete;
+
+    // Producer side
+    bool push(const T &item);
+    uint16_t push(const T *items, uint16_t n);
+
+    // Consumer side
+    uint16_t count();
+    T pop();
+    void clear();
+};
+
+template<class T>
+inline uint16_t SimpleRing<T>::load(index_t &i)
+{
+#if defined(__AVR__)
+    uint16_t value = i;
+    __asm__ __volatile__("" ::: "memory");
+    return value;
+#else
+    return i.load(std::memory_order_acquire);
+#endif
+}
+
+template<class T>
+inline void SimpleRing<T>::store(index_t &i, uint16_t value)
+{
+#if defined(__AVR__)
+    __asm__ __volatile__("" ::: "memory");
+    i = value;
+#else
+    i.store(value, std::memory_order_release);
+#endif
+}
+
+// Returns false if ring is full and item was dropped.
+template<class T>
+bool SimpleRing<T>::push(const T &item)
+{
+    uint16_t head = load(head_);
+    uint16_t new_head = next(head);
+    if (new_head == load(tail_))
+        return false;
+    data_[head] = item;
+    store(head_, new_head);
+    return true;
+}
+
+// Pushes up to n items. Returns number of items pushed, the rest are dropped.
+template<class T>
+uint16_t SimpleRing<T>::push(const T *items, uint16_t n)
+{
+    uint16_t head = load(head_);
+    uint16_t tail = load(tail_);
+    uint16_t pushed = 0;
+    while (pushed < n) {
+        uint16_t new_head = next(head);
+        if (new_head == tail)
+            break;
+        data_[head] = items[pushed++];
+        head = new_head;
+    }
+    store(head_, head);
+    return pushed;
+}
+
+template<class T>
+uint16_t SimpleRing<T>::count()
+{
+    uint16_t head = load(head_);
+    uint16_t tail = load(tail_);
+    return (head >= tail) ? head - tail : head + len_ - tail;
+}
+
+template<class T>
+T SimpleRing<T>::pop()
+{
+    uint16_t tail = load(tail_);
+    if (tail == load(head_)) return T(); // Returns empty
+    T result = data_[tail];
+    store(tail_, next(tail));
+    return result;
+}
+
+// Drops all items. Consumer side only.
+template<class T>
+void SimpleRing<T>::clear()
+{
+    store(tail_, load(head_));
+}
+
+#endif //SIMPLE_RING_H
@@ -1,4 +1,5 @@
 #include "SimpleSerial.h"
+#include "ReedSolomon.h"
 #include <string.h>
 
 /*
@@ -10,18 +11,238 @@ bool SimpleSerial::available() {
 
 /*
  * Takes payload (in bytes) and its id, frames it into a packet, and places it
- * in send queue.
+ * in send queue. Returns false if packet was dropped.
  */
-void SimpleSerial::send(uint8_t id, uint8_t len, uint8_t const *payload) {
+bool SimpleSerial::send(uint8_t id, uint8_t len, uint8_t const *payload) {
     // Check len
-    if (len > max_payload_len_) return;
+    if (len > max_payload_len_) return false;
 
     // Frame packet
     Packet packet(id, len, payload);
     Frame frame = build_frame(packet);
 
+    // Replace waiting frame of coalescing id
+    if (coalesce_slot && coalesce_slot[id] > COALESCE_IDLE) {
+        Frame &queued = send_queue.at(coalesce_slot[id] - 2);
+        tx_queued_bytes -= queued.len;
+        queued = frame;
+        tx_queued_bytes += frame.len;
+        return true;
+    }
+
     // Place packet in send queue
-    send_queue.push(frame);
+    uint16_t slot = send_queue.back();
+    if (send_queue.push(frame)) {
+        tx_queued_bytes += frame.len;
+        if (coalesce_slot && coalesce_slot[id] == COALESCE_IDLE)
+            coalesce_slot[id] = slot + 2;
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Same as send(), but places frame in front of send queue.
+ */
+bool SimpleSerial::send_priority(uint8_t id, uint8_t len, uint8_t const *payload) {
+    // Check len
+    if (len > max_payload_len_) return false;
+
+    // Frame packet
+    Packet packet(id, len, payload);
+    Frame frame = build_frame(packet);
+
+    bool waiting = coalesce_slot && coalesce_slot[id] > COALESCE_IDLE;
+    if (send_queue.push_front(frame)) {
+        tx_queued_bytes += frame.len;
+        if (waiting) {
+            // Older frame of coalescing id is replaced by an empty frame, which is skipped
+            Frame &queued = send_queue.at(coalesce_slot[id] - 2);
+            tx_queued_bytes -= queued.len;
+            queued = Frame();
+        }
+        if (coalesce_slot && coalesce_slot[id] != COALESCE_OFF)
+            coalesce_slot[id] = send_queue.front() + 2;
+        return true;
+    }
+    if (waiting) {
+        // Queue is full. Replace older frame of coalescing id in place.
+        Frame &queued = send_queue.at(coalesce_slot[id] - 2);
+        tx_queued_bytes -= queued.len;
+        queued = frame;
+        tx_queued_bytes += frame.len;
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Copies message and starts sending it in fragments. Each fragment payload
+ * starts with a header: message seq, offset and total message len (little endian).
+ */
+bool SimpleSerial::send_large(uint8_t id, uint16_t len, uint8_t const *payload) {
+    if (large_out.data || max_payload_len_ <= fragment_header_len)
+        return false;
+
+    large_out.id = id;
+    large_out.seq++;
+    large_out.len = len;
+    large_out.offset = 0;
+    large_out.data = new uint8_t[len > 0 ? len : 1];
+    memcpy(large_out.data, payload, len);
+    feed_large();
+    return true;
+}
+
+/*
+ * Queues next fragment of large message if send queue is empty.
+ */
+void SimpleSerial::feed_large() {
+    if (!large_out.data || send_queue.count() > 0)
+        return;
+
+    uint16_t chunk = large_out.len - large_out.offset;
+    if (chunk > max_payload_len_ - fragment_header_len)
+        chunk = max_payload_len_ - fragment_header_len;
+
+    uint8_t pld[fragment_header_len + chunk];
+    pld[0] = large_out.seq;
+    pld[1] = large_out.offset & 0xFF;
+    pld[2] = large_out.offset >> 8;
+    pld[3] = large_out.len & 0xFF;
+    pld[4] = large_out.len >> 8;
+    memcpy(pld + fragment_header_len, large_out.data + large_out.offset, chunk);
+    send(large_out.id, fragment_header_len + chunk, pld);
+
+    large_out.offset += chunk;
+    if (large_out.offset >= large_out.len) {
+        delete [] large_out.data;
+        large_out.data = nullptr;
+    }
+}
+
+void SimpleSerial::enable_reassembly(uint8_t id, uint16_t max_len) {
+    for (Reassembly *r = reassembly; r; r = r->next) {
+        if (r->id == id)
+            return;
+    }
+    Reassembly *r = new Reassembly();
+    r->id = id;
+    r->max_len = max_len;
+    r->data = new uint8_t[max_len > 0 ? max_len : 1];
+    r->next = reassembly;
+    reassembly = r;
+}
+
+/*
+ * If reassembly is enabled for received id, copies received fragment into
+ * reassembly buffer and returns true. Otherwise returns false.
+ */
+bool SimpleSerial::reassemble(uint32_t time) {
+    Reassembly *r = reassembly;
+    while (r && r->id != received_id)
+        r = r->next;
+    if (!r)
+        return false;
+
+    if (payload_i < fragment_header_len)
+        return true;
+    uint8_t seq = incoming_payload_[0];
+    uint16_t offset = incoming_payload_[1] | (incoming_payload_[2] << 8);
+    uint16_t len = incoming_payload_[3] | (incoming_payload_[4] << 8);
+    uint16_t chunk = payload_i - fragment_header_len;
+    bool valid = len <= r->max_len && chunk <= len && offset <= len - chunk;
+
+    // Fragments are sent in order, so a fragment continues current message only
+    // if it starts where the previous one ended
+    bool next = valid && r->active && r->seq == seq && r->len == len && r->received == offset &&
+                (time - r->last_time) <= receive_timeout;
+    if (!next) {
+        // Current message can not be completed any more
+        if (r->active) {
+            r->active = false;
+            large_drop_count++;
+        }
+
+        // A new message starts with offset 0 and only if previous one was read.
+        // Other fragments of a message that can not be received are dropped, message is counted once.
+        if (!valid || offset != 0 || r->complete) {
+            if (r->seq != seq || offset == 0)
+                large_drop_count++;
+            r->seq = seq;
+            return true;
+        }
+        r->active = true;
+        r->seq = seq;
+        r->len = len;
+        r->received = 0;
+    }
+    memcpy(r->data + offset, incoming_payload_ + fragment_header_len, chunk);
+    r->received += chunk;
+    r->last_time = time;
+
+    if (r->received >= r->len) {
+        r->active = false;
+        r->complete = true;
+    }
+    return true;
+}
+
+/*
+ * Discards incomplete large messages whose next fragment did not arrive within
+ * receive_timeout, also when the line went silent.
+ */
+void SimpleSerial::expire_reassembly(uint32_t time) {
+    for (Reassembly *r = reassembly; r; r = r->next) {
+        if (r->active && (time - r->last_time) > receive_timeout) {
+            r->active = false;
+            large_drop_count++;
+        }
+    }
+}
+
+uint16_t SimpleSerial::large_dropped() {
+    return large_drop_count;
+}
+
+bool SimpleSerial::large_available() {
+    for (Reassembly *r = reassembly; r; r = r->next) {
+        if (r->complete)
+            return true;
+    }
+    return false;
+}
+
+SimpleSerial::LargePacket SimpleSerial::read_large() {
+    for (Reassembly *r = reassembly; r; r = r->next) {
+        if (r->complete) {
+            r->complete = false;
+            return LargePacket(r->id, r->len, r->data);
+        }
+    }
+    return LargePacket();
+}
+
+/*
+ * Enables or disables coalescing for id. Returns false if coalescing can not be
+ * enabled because max_queue_len > 253.
+ */
+bool SimpleSerial::set_coalescing(uint8_t id, bool enable) {
+    if (!coalesce_slot) {
+        if (!enable)
+            return true;
+        if (send_queue.max_count() > 253)
+            return false;
+        coalesce_slot = new uint8_t[256];
+        memset(coalesce_slot, COALESCE_OFF, 256);
+    }
+    if (enable) {
+        if (coalesce_slot[id] == COALESCE_OFF)
+            coalesce_slot[id] = COALESCE_IDLE;
+    } else {
+        coalesce_slot[id] = COALESCE_OFF;
+    }
+    return true;
 }
 
 /*
@@ -61,15 +282,22 @@ SimpleSerial::Frame SimpleSerial::build_frame(Packet packet) {
     // Calculate CRC
     uint8_t crc = calc_CRC(payload, payload_len);
 
-    // Extend array to make place for CRC
-    uint8_t payload_new[payload_len + 1];
-    memcpy(payload_new, payload, payload_len);
-    payload = payload_new;
+    // Extend array to make place for id (covered by FEC), CRC and FEC parity
+    uint8_t block[payload_len + 2 + fec_parity_len];
+    block[0] = id;
+    memcpy(block + 1, payload, payload_len);
+    payload = block + 1;
     payload_len++;
 
     // Insert CRC byte to the end of payload
     payload[payload_len - 1] = crc;
 
+    // Insert FEC parity bytes, calculated over id, payload and CRC
+    if (fec_parity_len) {
+        reed_solomon::encode(block, payload_len + 1, payload + payload_len, fec_parity_len);
+        payload_len += fec_parity_len;
+    }
+
     Frame frame(max_frame_len_);
 
     // Insert ESC flags
@@ -106,16 +334,113 @@ SimpleSerial::Frame SimpleSerial::build_frame(Packet packet) {
  * Continuously running loop. Sends the next packet in send queue.
  */
 void SimpleSerial::send_loop() {
+    feed_large();
+    skip_empty_frames();
     if (send_queue.count() <= 0)
         // Return if nothing to send
         return;
     else {
+        // Wait if sending is paced
+        if (tx_byte_time && !take_tx_credit(send_queue.at(send_queue.front()).len))
+            return;
+
         // Send packet
-        Frame frame = send_queue.pop();
+        Frame frame = pop_frame();
         serial_->write(frame.data, frame.len);
         }
 }
 
+/*
+ * Sends the next frame in send queue if it fits into *space* bytes of free
+ * serial TX buffer. Returns true if a frame was sent.
+ */
+bool SimpleSerial::send_next(uint16_t space) {
+    skip_empty_frames();
+    if (send_queue.count() <= 0)
+        return false;
+
+    // Capacity of TX buffer is estimated as the largest free space seen, unless it was set
+    if (space > tx_space_max)
+        tx_space_max = space;
+    uint16_t capacity = tx_buffer_len ? tx_buffer_len : tx_space_max;
+
+    // Wait for space. Frame larger than the whole TX buffer is written when the
+    // buffer is empty, write blocks until the rest of the frame fits.
+    uint8_t len = send_queue.at(send_queue.front()).len;
+    if (len > space && !(len > capacity && space >= capacity))
+        return false;
+
+    // Wait if sending is paced
+    if (tx_byte_time && !take_tx_credit(len))
+        return false;
+
+    Frame frame = pop_frame();
+    serial_->write(frame.data, frame.len);
+    return true;
+}
+
+/*
+ * Refills token bucket according to elapsed time and takes credit for *len* bytes.
+ * Returns false if there is not enough credit yet. A frame larger than the bucket
+ * is let through when the bucket is full and leaves the credit negative.
+ */
+bool SimpleSerial::take_tx_credit(uint8_t len) {
+    uint32_t now = sys_time_us();
+    uint32_t elapsed = now - tx_credit_time;
+    tx_credit_time = now;
+    uint32_t missing = tx_credit_max - tx_credit;
+    if (elapsed > (missing >> 4))
+        tx_credit = tx_credit_max;
+    else
+        tx_credit += (int32_t) (elapsed << 4);
+    if (tx_credit > tx_credit_max)
+        tx_credit = tx_credit_max;
+
+    int32_t cost = len * tx_byte_time;
+    if (cost > tx_credit && tx_credit < tx_credit_max)
+        return false;
+    tx_credit -= cost;
+    return true;
+}
+
+void SimpleSerial::set_baud_rate(uint32_t baud, uint8_t bits_per_byte, uint16_t burst_bytes) {
+    if (baud == 0 || (!micros_getter && !time_getter)) {
+        tx_byte_time = 0;
+        return;
+    }
+    // Round up, so that pacing is never faster than line rate
+    tx_byte_time = (16000000UL * bits_per_byte + baud - 1) / baud;
+    if (burst_bytes == 0)
+        burst_bytes = 1;
+    tx_credit_max = burst_bytes * tx_byte_time;
+    tx_credit = tx_credit_max;
+    tx_credit_time = sys_time_us();
+}
+
+/*
+ * Removes empty frames (left by send_priority() in place of replaced frames)
+ * from front of send queue.
+ */
+void SimpleSerial::skip_empty_frames() {
+    while (send_queue.count() > 0 && send_queue.at(send_queue.front()).len == 0)
+        pop_frame();
+}
+
+/*
+ * Removes the oldest frame from send queue and updates send queue bookkeeping.
+ */
+SimpleSerial::Frame SimpleSerial::pop_frame() {
+    uint16_t slot = send_queue.front();
+    Frame frame = send_queue.pop();
+    tx_queued_bytes -= frame.len;
+    if (coalesce_slot && frame.len > 2) {
+        uint8_t id = frame.data[2];
+        if (coalesce_slot[id] == slot + 2)
+            coalesce_slot[id] = COALESCE_IDLE;
+    }
+    return frame;
+}
+
 /*
  * Returns and removes the oldest packet in the read queue.
  */
@@ -128,86 +453,274 @@ SimpleSerial::Packet SimpleSerial::read() {
  * decodes the packet. Reads *read_num_bytes* in one iteration.
  */
 void SimpleSerial::read_loop() {
-    for (uint8_t k = 0; k < read_num_bytes; ++k) {
+    uint32_t time = sys_time();
+    uint16_t n = rx_available();
+    if (n > read_num_bytes)
+        n = read_num_bytes;
+    read_bytes(n, time);
+    expire_reassembly(time);
+}
 
-        uint32_t time = sys_time();
+/*
+ * Returns number of received bytes waiting in receive ring if enabled,
+ * otherwise in serial interface.
+ */
+uint16_t SimpleSerial::rx_available() {
+    if (rx_ring)
+        return rx_ring->count();
+    return serial_->available();
+}
 
-        if (!serial_->available())
-            return;
+/*
+ * Reads *n* bytes from receive ring or serial interface and decodes them.
+ * Caller must make sure that *n* bytes are available.
+ */
+void SimpleSerial::read_bytes(uint16_t n, uint32_t time) {
+    if (rx_ring) {
+        for (uint16_t k = 0; k < n; ++k)
+            decode_byte(rx_ring->pop(), time);
+    } else {
+        for (uint16_t k = 0; k < n; ++k)
+            decode_byte(serial_->read(), time);
+    }
+}
 
-        uint8_t b = serial_->read();
-        if (byte_count == 0 && b == start_flag) {
-            // First byte - START flag. Start count.
-            start_time = time;
-            byte_count = 1;
-            payload_i = 0;
-            esc_active = false;
-        } else if (byte_count == 1) {
-            // Second byte - packet length
-            received_frame_len = b;
-            byte_count = 2;
-        } else if (byte_count == 2) {
-            // Third byte - packet identifier
-            received_id = b;
-            byte_count = 3; 
-        } else if (byte_count > 2) {
-            // Data value byte
-            if (byte_count > (max_frame_len_) || (time - start_time) > receive_timeout) {
-                // No END flag. Reset.
-                byte_count = 0;
-                return;
-            }
-            if (!esc_active) {
-                // No preceding ESC. Accept flags.
-                if (b == esc_flag)
-                    // ESC flag. Activate ESC mode.
-                    esc_active = true;
-                else if (b == end_flag) {
-                    // End of packet. Check if specified and actual length are equal.
+void SimpleSerial::enable_rx_ring(uint16_t len) {
+#if defined(__AVR__)
+    if (len > 254) len = 254;
+#endif
+    delete rx_ring;
+    rx_ring = new SimpleRing<uint8_t>(len);
+}
+
+/*
+ * Producer side of receive ring. Wait-free, may be called from an interrupt.
+ */
+bool SimpleSerial::on_rx_byte(uint8_t b) {
+    if (!rx_ring) return false;
+    return rx_ring->push(b);
+}
+
+uint16_t SimpleSerial::on_rx_block(const uint8_t *buf, uint16_t n) {
+    if (!rx_ring) return 0;
+    return rx_ring->push(buf, n);
+}
+
+/*
+ * Decodes a single received byte. When a complete valid frame is decoded,
+ * packet is placed in receive queue.
+ */
+void SimpleSerial::decode_byte(uint8_t b, uint32_t time) {
+    if (byte_count == 0 && b == start_flag) {
+        // First byte - START flag. Start count.
+        if (!incoming_payload_)
+            incoming_payload_ = new uint8_t[incoming_len_];
+        start_time = time;
+        byte_count = 1;
+        payload_i = 0;
+        esc_active = false;
+    } else if (byte_count == 1) {
+        // Second byte - packet length
+        received_frame_len = b;
+        byte_count = 2;
+    } else if (byte_count == 2) {
+        // Third byte - packet identifier
+        received_id = b;
+        byte_count = 3; 
+    } else if (byte_count > 2) {
+        // Data value byte
+        if (byte_count > (max_frame_len_) || (time - start_time) > receive_timeout) {
+            // No END flag. Reset.
+            byte_count = 0;
+            return;
+        }
+        if (!esc_active) {
+            // No preceding ESC. Accept flags.
+            if (b == esc_flag)
+                // ESC flag. Activate ESC mode.
+                esc_active = true;
+            else if (b == end_flag) {
+                // End of packet. Correct errors if FEC is enabled, otherwise
+                // check if specified and actual length are equal.
+                bool valid;
+                if (fec_parity_len)
+                    valid = fec_decode();
+                else
+                    valid = (payload_i > 0) && (byte_count == received_frame_len - 1);
+
+                if (valid) {
                     uint8_t crc_received = incoming_payload_[payload_i - 1];
-                    uint8_t crc_calculated = calc_CRC(incoming_payload_, payload_i - 1);
                     payload_i--;
+                    valid = (crc_received == calc_CRC(incoming_payload_, payload_i));
+                }
 
-                    if ((byte_count == received_frame_len - 1) && (crc_received == crc_calculated)) {
-                        // Valid data. Add to read queue.
+                if (valid) {
+                    // Valid data. Add to read queue or reassembly buffer.
+                    if (!reassemble(time)) {
                         Packet packet(received_id, payload_i, incoming_payload_);
                         receive_queue.push(packet);
-                        byte_count = 0;
-                    } else {
-                        // CORRUPTED data. Reset
-                        byte_count = 0;
-                        esc_active = false;
                     }
-                    return;
+                    byte_count = 0;
                 } else {
-                    // Normal data byte. Add to array.
-                    if (payload_i < max_payload_len_) {
-                        incoming_payload_[payload_i] = b;
-                        payload_i++;
-                    }
-                    else {
-                        // Restart
-                        byte_count = 0;
-                        return;
-                    }
-
+                    // CORRUPTED data. Reset
+                    byte_count = 0;
+                    esc_active = false;
                 }
+                return;
             } else {
-                // ESC preceding. Ignore flag following ESC byte.
-                incoming_payload_[payload_i] = b;
-                payload_i++;
-                esc_active = false;
+                // Normal data byte. Add to array.
+                if (payload_i < incoming_len_) {
+                    incoming_payload_[payload_i] = b;
+                    payload_i++;
+                }
+                else {
+                    // Restart
+                    byte_count = 0;
+                    return;
+                }
+
+            }
+        } else {
+            // ESC preceding. Ignore flag following ESC byte.
+            if (payload_i >= incoming_len_) {
+                // Restart
+                byte_count = 0;
+                return;
             }
-            byte_count++;
+            incoming_payload_[payload_i] = b;
+            payload_i++;
+            esc_active = false;
         }
+        byte_count++;
     }
 }
 
+/*
+ * Corrects errors in received id, payload and CRC using FEC parity bytes at the
+ * end of incoming payload and removes parity bytes. Returns false if errors can
+ * not be corrected.
+ */
+bool SimpleSerial::fec_decode() {
+    if (payload_i <= fec_parity_len)
+        return false;
+
+    fec_block[0] = received_id;
+    memcpy(fec_block + 1, incoming_payload_, payload_i);
+    if (!reed_solomon::decode(fec_block, payload_i + 1, fec_parity_len))
+        return false;
+
+    payload_i -= fec_parity_len;
+    received_id = fec_block[0];
+    memcpy(incoming_payload_, fec_block + 1, payload_i);
+    return true;
+}
+
+bool SimpleSerial::set_fec(uint8_t parity_len) {
+    // Fully escaped frame (start, len, id, payload, CRC, parity, end) must fit in 255 bytes,
+    // frame length is sent in one byte
+    if (parity_len > reed_solomon::max_parity_len ||
+        (parity_len && 2 * (max_payload_len_ + 1 + parity_len) + 4 > 255))
+        return false;
+
+    fec_parity_len = parity_len;
+    max_frame_len_ = 2 * (max_payload_len_ + parity_len) + 20;
+    if (max_frame_len_ > 255)
+        max_frame_len_ = 255;
+    incoming_len_ = max_payload_len_ + 1 + parity_len;
+    delete [] incoming_payload_;
+    incoming_payload_ = nullptr;
+    delete [] fec_block;
+    fec_block = parity_len ? new uint8_t[incoming_len_ + 1] : nullptr;
+    byte_count = 0;
+    return true;
+}
+
 void SimpleSerial::loop() {
     send_loop();
     read_loop();
 }
 
+/*
+ * Budgeted loop. Alternates between sending queued frames (as long as they fit
+ * into free space of serial TX buffer) and decoding received bytes (at most one
+ * max length frame at a time), until there is no work left or time / byte budget
+ * is used up. A budget_us of 0 disables the time limit.
+ */
+uint16_t SimpleSerial::loop(uint32_t budget_us, uint16_t max_bytes) {
+    uint32_t start_us = budget_us ? sys_time_us() : 0;
+    uint32_t time = 0;
+    uint16_t done = 0;
+    uint16_t rx_read = 0;
+    uint16_t rx_waiting = 0;
+    bool rx_checked = false;
+
+    while (done < max_bytes) {
+        bool progress = false;
+
+        // Send next frame. It may exceed the byte budget, so a frame longer
+        // than max_bytes is still sent.
+        feed_large();
+        skip_empty_frames();
+        if (send_queue.count() > 0) {
+            uint8_t len = send_queue.at(send_queue.front()).len;
+            if (send_next(serial_->available_for_write())) {
+                done += len;
+                progress = true;
+            }
+        }
+        if (done >= max_bytes)
+            break;
+
+        // Decode received bytes, at most as many as are waiting
+        if (rx_waiting == 0) {
+            rx_waiting = rx_available();
+            rx_checked = true;
+        }
+        uint16_t n = rx_waiting;
+        uint16_t remaining = max_bytes - done;
+        if (n > remaining)
+            n = remaining;
+        if (n > max_frame_len_)
+            n = max_frame_len_;
+
+        // Decode no more frames than fit into receive queue. Shortest frame is
+        // min_frame_len bytes, the first one may be partly received already.
+        uint16_t queue_free = receive_queue.max_count() - receive_queue.count();
+        if (queue_free == 0)
+            n = 0;
+        else if (n > (queue_free - 1) * min_frame_len + 1)
+            n = (queue_free - 1) * min_frame_len + 1;
+        if (n > 0) {
+            if (rx_read == 0)
+                time = sys_time();
+            read_bytes(n, time);
+            rx_read += n;
+            rx_waiting -= n;
+            done += n;
+            progress = true;
+        }
+
+        if (!progress || (budget_us && sys_time_us() - start_us >= budget_us))
+            break;
+    }
+
+    if (reassembly)
+        expire_reassembly(rx_read ? time : sys_time());
+
+    // Nothing was read, so last rx_available() is still up to date
+    if (rx_read == 0 && rx_checked)
+        return rx_waiting + tx_queued_bytes;
+    return rx_available() + tx_queued_bytes;
+}
+
+void SimpleSerial::set_tx_buffer_len(uint16_t len) {
+    tx_buffer_len = len;
+}
+
+void SimpleSerial::set_micros_getter(unsigned long (*micros_getter)()) {
+    this->micros_getter = micros_getter;
+}
+
 void SimpleSerial::confirm_received(uint8_t id) {
     uint8_t pld[] = "ok";
     send(id, 2, pld);
@@ -227,6 +740,16 @@ uint32_t SimpleSerial::sys_time() {
     return time;
 }
 
+/*
+ * Return system time in us if micros_getter is set, otherwise derive it from
+ * time_getter. Returns 0 if neither is set.
+ */
+uint32_t SimpleSerial::sys_time_us() {
+    if (micros_getter)
+        return (uint32_t) micros_getter();
+    return sys_time() * 1000UL;
+}
+
 // Automatically generated CRC function from python crcmod
 // CRC-8; polynomial: 0x107
 uint8_t SimpleSerial::calc_CRC(uint8_t *data, uint8_t len)
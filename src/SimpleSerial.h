@@ -8,6 +8,7 @@
 #include <stdint.h>
 #include <string.h>
 #include "SimpleQueue.h"
+#include "SimpleRing.h"
 
 
 class SimpleSerial {
@@ -22,11 +23,11 @@ public:
         uint8_t payload_len;
         uint8_t *payload;
     public:
-        Packet()
+        Packet() // Empty packet shares a single zero byte instead of allocating
             : id(0)
             , payload_len(0)
-            , payload(new uint8_t[1])
-            {payload[0] = 0;}
+            , payload(empty_payload())
+            {}
         Packet(uint8_t id, uint8_t payload_len)
                 : id(id)
                 , payload_len(payload_len)
@@ -37,7 +38,7 @@ public:
             , payload_len(payload_len)
             , payload(new uint8_t[payload_len])
             {memcpy(this->payload, payload, payload_len);}
-        ~Packet() {delete [] payload;}
+        ~Packet() {release();}
         Packet(const Packet &old_packet) {
             id = old_packet.id;
             payload_len = old_packet.payload_len;
@@ -55,11 +56,70 @@ public:
                 return *this;
             id = rhs.id;
             payload_len = rhs.payload_len;
-            delete[] payload;
+            release();
             payload = new uint8_t[payload_len];
             memcpy(payload, rhs.payload, payload_len);
             return *this;
         }
+    private:
+        static uint8_t *empty_payload() {
+            static uint8_t zero = 0;
+            return &zero;
+        }
+        void release() {
+            if (payload != empty_payload())
+                delete [] payload;
+        }
+    };
+
+    // Message reassembled from fragments sent with send_large()
+    struct LargePacket {
+        uint8_t id;
+        uint16_t payload_len;
+        uint8_t *payload;
+    public:
+        LargePacket() // Empty packet shares a single zero byte instead of allocating
+            : id(0)
+            , payload_len(0)
+            , payload(empty_payload())
+            {}
+        LargePacket(uint8_t id, uint16_t payload_len, const uint8_t *payload)
+            : id(id)
+            , payload_len(payload_len)
+            , payload(new uint8_t[payload_len])
+            {memcpy(this->payload, payload, payload_len);}
+        ~LargePacket() {release();}
+        LargePacket(const LargePacket &old_packet) {
+            id = old_packet.id;
+            payload_len = old_packet.payload_len;
+            payload = new uint8_t[payload_len];
+            memcpy(payload, old_packet.payload, payload_len);
+        }
+        LargePacket(LargePacket&& old_packet) {
+            id = old_packet.id;
+            payload_len = old_packet.payload_len;
+            payload = old_packet.payload;
+            old_packet.payload = nullptr;
+        }
+        LargePacket& operator=(const LargePacket& rhs) {
+            if (this == &rhs)
+                return *this;
+            id = rhs.id;
+            payload_len = rhs.payload_len;
+            release();
+            payload = new uint8_t[payload_len];
+            memcpy(payload, rhs.payload, payload_len);
+            return *this;
+        }
+    private:
+        static uint8_t *empty_payload() {
+            static uint8_t zero = 0;
+            return &zero;
+        }
+        void release() {
+            if (payload != empty_payload())
+                delete [] payload;
+        }
     };
 
     /*
@@ -67,6 +127,7 @@ public:
     *   virtual uint8_t available() = 0;
     *   virtual uint8_t read() = 0;
     *   virtual uint8_t write(uint8_t b[], uint8_t len) = 0;
+    * If the object also has availableForWrite(), loop(budget_us) uses it to avoid blocking writes.
     * 
     * Other arguments are optional.
     * */
@@ -89,13 +150,25 @@ public:
                 , esc_flag(esc_flag)
                 , start_flag(start_flag)
                 , end_flag(end_flag)
-                , incoming_payload_(new uint8_t[max_payload_len_])
+                , incoming_len_(max_payload_len_ + 1)
+                , incoming_payload_(nullptr)
                 , receive_queue(max_queue_len)
                 , send_queue(max_queue_len)
             {};
     SimpleSerial(const SimpleSerial&) = delete; // delete copy constructor
     ~SimpleSerial() {
+        delete serial_;
         delete [] incoming_payload_;
+        delete rx_ring;
+        delete [] coalesce_slot;
+        delete [] fec_block;
+        delete [] large_out.data;
+        while (reassembly) {
+            Reassembly *next = reassembly->next;
+            delete [] reassembly->data;
+            delete reassembly;
+            reassembly = next;
+        }
     };
 
     // Returns true if packets are available to read
@@ -104,8 +177,35 @@ public:
     // Return a packet from receive queue
     Packet read();
 
-    // Send packet with id, length and payload array
-    void send(uint8_t id, uint8_t len, uint8_t const payload[]);
+    // Send packet with id, length and payload array. Returns false if payload is too long or send queue is full.
+    bool send(uint8_t id, uint8_t len, uint8_t const payload[]);
+
+    // Send packet ahead of all packets waiting in send queue. For a coalescing id, an older packet
+    // with the same id still waiting in send queue is discarded. Returns false if payload is too long
+    // or send queue is full.
+    bool send_priority(uint8_t id, uint8_t len, uint8_t const payload[]);
+
+    // Send message longer than max_payload_len as fragments of at most max_payload_len (5 bytes of
+    // each are used for fragment header). Message is copied. Next fragment is queued only when send
+    // queue is empty, so other packets are sent in between. One large message is sent at a time,
+    // returns false if previous one is still being sent.
+    bool send_large(uint8_t id, uint16_t len, uint8_t const payload[]);
+
+    // Reassemble large messages of up to max_len bytes sent with send_large() for id. Packets with
+    // this id are no longer placed in receive queue. Buffer of max_len bytes is allocated for id.
+    // Incomplete message is discarded if a fragment is missing or next fragment does not arrive
+    // within receive_timeout (checked by loop() also when nothing is received). A message that starts
+    // while previous one of the same id was not read yet is discarded too.
+    void enable_reassembly(uint8_t id, uint16_t max_len);
+
+    // Returns true if a reassembled large message is available to read
+    bool large_available();
+
+    // Return a reassembled large message. Each message is returned once.
+    LargePacket read_large();
+
+    // Number of discarded large messages (all ids). Wraps around at 65535.
+    uint16_t large_dropped();
 
     // Send float
     void send_float(uint8_t id, float f);
@@ -113,9 +213,58 @@ public:
     // Send int
     void send_int(uint8_t id, int32_t i);
 
+    // Mark id as coalescing (latest value wins). Sending a packet with this id while an older
+    // one is still waiting in send queue replaces the older one in place. Returns false if coalescing
+    // can not be enabled (requires max_queue_len <= 253).
+    bool set_coalescing(uint8_t id, bool enable = true);
+
     // Handler loop. Must be called periodically from main program.
     void loop();
 
+    // Budgeted handler loop. Decodes all received bytes and sends queued frames while
+    // serial interface has room for them, until there is no work left or budget_us [us]
+    // or max_bytes is used up. A frame is sent even if it is longer than what is left of
+    // max_bytes, received bytes are decoded only within max_bytes. Decoding stops while receive
+    // queue is full, so no packets are dropped. Returns number of bytes still waiting to be
+    // processed (received and not decoded + queued and not sent).
+    uint16_t loop(uint32_t budget_us, uint16_t max_bytes = 0xFFFF);
+
+    // Set capacity of serial TX buffer (e.g. 63 on AVR Arduino cores). loop(budget_us) writes a frame
+    // only when availableForWrite() reports room for it. Frames larger than the whole TX buffer are
+    // written when the buffer is empty, and that write blocks. Without this setting capacity is
+    // estimated as the largest availableForWrite() seen, so such a frame may be written into a
+    // buffer that is not yet empty if loop(budget_us) never saw it empty before.
+    void set_tx_buffer_len(uint16_t len);
+
+    // Use a receive ring of len bytes, filled with on_rx_byte() / on_rx_block(), instead of
+    // reading from serial interface. Must be called before the first byte is pushed.
+    void enable_rx_ring(uint16_t len);
+
+    // Push received bytes to receive ring. Safe to call from an interrupt handler or
+    // DMA callback while main program is calling loop(). Bytes that do not fit into the ring
+    // are dropped: on_rx_byte() returns false, on_rx_block() returns number of bytes accepted.
+    bool on_rx_byte(uint8_t b);
+    uint16_t on_rx_block(const uint8_t *buf, uint16_t n);
+
+    // Pace sending to line rate. Frames are released only when a token bucket of
+    // burst_bytes has enough credit, so writes never fill up serial TX buffer and loop()
+    // does not block as long as burst_bytes is not larger than the TX buffer (63 bytes on AVR
+    // Arduino cores). A frame larger than burst_bytes is released when the bucket is full.
+    // bits_per_byte includes start, parity and stop bits (10 for 8N1). baud = 0 disables pacing.
+    // Requires micros_getter or time_getter to be set before calling.
+    void set_baud_rate(uint32_t baud, uint8_t bits_per_byte = 10, uint16_t burst_bytes = 63);
+
+    // Enable forward error correction with parity_len Reed-Solomon parity bytes per frame
+    // (0 disables it). Up to parity_len / 2 corrupted bytes in id, payload and CRC are
+    // corrected before CRC check. Both sides must use the same setting. Returns false if
+    // parity_len > 32 or a fully escaped frame (2 * (max_payload_len + 1 + parity_len) + 4 bytes)
+    // would not fit in 255 bytes.
+    bool set_fec(uint8_t parity_len);
+
+    // Set function that returns system time in us, like micros(). Used by loop(budget_us).
+    // If not set, time_getter is used with ms resolution.
+    void set_micros_getter(unsigned long (*micros_getter)());
+
     // Sends "ok" as payload
     void confirm_received(uint8_t id);
 
@@ -123,9 +272,11 @@ private:
     // Using type erasure pattern for serial interface
     class SerialConcept {
     public:
+        virtual ~SerialConcept() {};
         virtual uint8_t available() = 0;
         virtual uint8_t read() = 0;
         virtual uint8_t write(uint8_t b[], uint8_t len) = 0;
+        virtual uint16_t available_for_write() = 0;
     };
 
     template <class T>
@@ -135,8 +286,17 @@ private:
         uint8_t available() override { return serial_->available(); };
         uint8_t read() override { return serial_->read(); };
         uint8_t write(uint8_t b[], uint8_t len) override { return serial_->write(b, len);} ;
+        uint16_t available_for_write() override { return write_space(serial_, 0); };
     private:
         T* serial_;
+
+        // Use availableForWrite() if serial interface has it, otherwise assume unlimited space
+        template <class U>
+        static auto write_space(U* s, int) -> decltype(s->availableForWrite(), uint16_t()) {
+            return s->availableForWrite();
+        }
+        template <class U>
+        static uint16_t write_space(U*, long) { return 0xFFFF; }
     };
 
     SerialConcept* serial_;
@@ -146,10 +306,10 @@ private:
         uint8_t len;
         uint8_t *data;
     public:
-        Frame()
+        Frame() // Empty frame holds no buffer
             : len(0)
-            , data(new uint8_t[1])
-            {data[0] = 0;}
+            , data(nullptr)
+            {}
         explicit Frame(uint8_t len)
                 : len(len)
                 , data(new uint8_t[len])
@@ -162,8 +322,9 @@ private:
         ~Frame() {delete [] data;}
         Frame(const Frame& old_frame) {
             len = old_frame.len;
-            data = new uint8_t[len];
-            memcpy(data, old_frame.data, len);
+            data = old_frame.data ? new uint8_t[len] : nullptr;
+            if (data)
+                memcpy(data, old_frame.data, len);
         }
         Frame(Frame&& old_frame) {
             len = old_frame.len;
@@ -174,15 +335,16 @@ private:
             if (this == &rhs)
                 return *this;
             len = rhs.len;
-            delete[] data;
-            data = new uint8_t[rhs.len];
-            memcpy(data, rhs.data, len);
+            delete [] data;
+            data = rhs.data ? new uint8_t[rhs.len] : nullptr;
+            if (data)
+                memcpy(data, rhs.data, len);
             return *this;
         }
     };
 
     const uint16_t max_payload_len_;
-    const uint16_t max_frame_len_; // Maximum frame length
+    uint16_t max_frame_len_; // Maximum frame length
 
     const uint16_t receive_timeout;   // Packet receive timeout
     const uint8_t read_num_bytes;    // number of bytes to read in single readLoop()
@@ -196,6 +358,17 @@ private:
 
     void read_loop();
     void send_loop();
+    uint16_t rx_available();
+    void read_bytes(uint16_t n, uint32_t time);
+    void decode_byte(uint8_t b, uint32_t time);
+    bool send_next(uint16_t space);
+    bool fec_decode();
+    void feed_large();
+    bool reassemble(uint32_t time);
+    void expire_reassembly(uint32_t time);
+    Frame pop_frame();
+    void skip_empty_frames();
+    bool take_tx_credit(uint8_t len);
 
     uint8_t byte_count = 0;
     uint8_t received_frame_len = 0;
@@ -203,10 +376,58 @@ private:
     bool esc_active = false;
     uint8_t payload_i = 0;
     uint32_t start_time = 0;
-    uint8_t *incoming_payload_;
+    uint16_t incoming_len_;  // Size of incoming payload buffer (payload, CRC and FEC parity)
+    uint8_t *incoming_payload_;     // Allocated when first frame starts
+    uint8_t fec_parity_len = 0;     // Number of FEC parity bytes, 0 if FEC is disabled
+    uint8_t *fec_block = nullptr;   // Error correction buffer (id + incoming payload)
+    SimpleRing<uint8_t> *rx_ring = nullptr; // Receive ring, if enabled
+    static const uint8_t min_frame_len = 5; // START, LEN, ID, CRC, END
+
+    // Send queue slot + 2 of waiting frame for each coalescing id (allocated on first use)
+    static const uint8_t COALESCE_OFF = 0;   // id is not coalescing
+    static const uint8_t COALESCE_IDLE = 1;  // id is coalescing, no frame waiting
+    uint8_t *coalesce_slot = nullptr;
+
+    // Large message being sent with send_large()
+    static const uint8_t fragment_header_len = 5; // message seq, offset (2), total len (2)
+    struct LargeOut {
+        uint8_t id = 0;
+        uint8_t seq = 0;
+        uint16_t len = 0;
+        uint16_t offset = 0;
+        uint8_t *data = nullptr; // nullptr if no message is being sent
+    } large_out;
+
+    // Reassembly buffer of id enabled with enable_reassembly()
+    struct Reassembly {
+        uint8_t id;
+        uint16_t max_len;
+        uint8_t *data;
+        bool active;        // fragments of message are being received
+        bool complete;      // whole message received and not read yet
+        uint8_t seq;
+        uint16_t len;
+        uint16_t received;  // number of bytes received, offset of next fragment
+        uint32_t last_time; // time of last fragment
+        Reassembly *next;
+    };
+    Reassembly *reassembly = nullptr;
+    uint16_t large_drop_count = 0;
+
+    uint16_t tx_queued_bytes = 0;   // Bytes of frames waiting in send queue
+    uint16_t tx_buffer_len = 0;     // Capacity of serial TX buffer, 0 if unknown
+    uint16_t tx_space_max = 0;      // Largest free space seen in serial TX buffer
+
+    // Send pacing token bucket. Credit is line time in 1/16 us.
+    uint32_t tx_byte_time = 0;      // Line time of one byte, 0 if pacing is disabled
+    int32_t tx_credit = 0;          // Negative after a frame larger than the bucket
+    int32_t tx_credit_max = 0;
+    uint32_t tx_credit_time = 0;    // [us] Time of last refill
 
     unsigned long (*time_getter)() = nullptr;
+    unsigned long (*micros_getter)() = nullptr;
     uint32_t sys_time();
+    uint32_t sys_time_us();
 
 };
 